@@ -0,0 +1,13 @@
+#ifndef DMDGP_H
+#define DMDGP_H
+
+// Umbrella header for libdmdgp (build/libdmdgp.a, build/libdmdgp.so).
+
+#include "geom.h"
+#include "instance.h"
+#include "landscape.h"
+#include "mat4.h"
+#include "score.h"
+#include "search.h"
+
+#endif // DMDGP_H
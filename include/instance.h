@@ -3,6 +3,7 @@
 
 #include "mat4.h"
 #include <stddef.h>
+#include <stdio.h>
 
 typedef struct {
     int u, v;  // 1-based
@@ -30,21 +31,68 @@ typedef struct {
     Mat4 *A_plus;  // A_plus[t] uses sw = +abs_sw[t]
     Mat4 *A_minus; // A_minus[t] uses sw = -abs_sw[t]
 
+    // Vertex relabeling (1..n): internal vertex i is original vertex orig[i].
+    // NULL means the identity (no instance_remap() applied).
+    int *orig;
+
 } Instance;
 
 // Load file, allocate matrices, store edges/distances.
 // Returns 1 on success, 0 on failure (prints error to stderr).
 int instance_load(const char *path, Instance *I);
 
+// Same as instance_load(), reading the instance text from an open stream.
+// The stream is not closed.
+int instance_load_stream(FILE *f, Instance *I);
+
 // Validate DMDGP-required distances for the vertex order 1..n.
 // Returns 1 if valid, 0 if invalid (prints the missing requirements).
 int instance_validate_dmdgp(const Instance *I);
 
-// Precompute theta, cw, abs_sw.
+// Check (silently) whether order[1..n] (original ids) is a valid DMDGP
+// discretization order. order == NULL checks the identity order 1..n.
+int instance_check_order(const Instance *I, const int *order);
+
+// Search for a valid discretization order: every vertex must have distances
+// to its three predecessors (and the first three form a triangle). Among
+// the orders found, prefer the one that completes the pruning edges
+// (|pos(u) - pos(v)| > 3) earliest, i.e. minimizes the sum of their
+// completion positions. The identity order is kept unless beaten.
+// Returns 1 and fills order[1..n] with original ids, or 0 if none found.
+int instance_find_order(const Instance *I, int *order);
+
+// Relabel vertices so that internal vertex i is original vertex order[i].
+// Must be called before instance_precompute(). Records the map in I->orig.
+// Returns 1 on success, 0 on failure.
+int instance_remap(Instance *I, const int *order);
+
+// instance_find_order() + instance_remap().
+// Returns 1 on success, 0 on failure (prints error to stderr).
+int instance_reorder(Instance *I);
+
+// Print "VERTEX ORDER: orig[1] ... orig[n]" if the instance was remapped.
+// Mask bit (n - t) then refers to original vertex orig[t].
+void instance_print_order(const Instance *I, FILE *f);
+
+// Scatter points x[1..n] (internal ids) to y[1..n] (original ids).
+void instance_points_to_original(const Instance *I, const Vec3 *x, Vec3 *y);
+
+// Precompute theta, cw, abs_sw, and sort E by completion level max(u,v).
 // Requires instance_validate_dmdgp() to be true.
 // Returns 1 on success, 0 on numerical failure (prints details).
 int instance_precompute(Instance *I);
 
+// Everything a loaded instance needs before searching: re-order the
+// vertices if force_reorder is set or 1..n is not a valid order, then
+// validate and precompute. Returns 1 on success, 0 on failure (prints
+// error to stderr); if why != NULL it is then set to a short reason
+// ("no_vertex_order", "not_dmdgp" or "precompute_failed").
+int instance_prepare(Instance *I, int force_reorder, const char **why);
+
+// Command-line helper: consume a leading "-r" (force re-ordering) from
+// argc/argv, keeping argv[0]. Returns 1 if it was present.
+int instance_take_reorder_flag(int *argc, char ***argv);
+
 // Free memory.
 void instance_free(Instance *I);
 
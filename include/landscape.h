@@ -0,0 +1,44 @@
+#ifndef LANDSCAPE_H
+#define LANDSCAPE_H
+
+#include <stdint.h>
+#include "instance.h"
+
+// Log-scale histogram of g values.
+// Bin b (0..nbins-1) covers [10^(log10_min + b/per_decade),
+//                            10^(log10_min + (b+1)/per_decade)).
+typedef struct {
+    int per_decade;     // bins per decade (> 0)
+    int nbins;          // number of regular bins
+    double log10_min;   // lower edge of bin 0 (in decades)
+    uint64_t *count;    // length nbins
+    uint64_t underflow; // g < 10^log10_min (including g == 0)
+    uint64_t overflow;  // g >= upper edge of last bin, or non-finite
+} LandscapeHist;
+
+typedef struct {
+    uint64_t total; // number of masks written (2^(n-3))
+    uint64_t k_min; // argmin g
+    double g_min;   // min g
+} LandscapeStats;
+
+// Allocate a histogram covering [10^log10_min, 10^log10_max).
+// Returns 1 on success, 0 on failure.
+int landscape_hist_init(LandscapeHist *H, double log10_min, double log10_max,
+                        int per_decade);
+void landscape_hist_free(LandscapeHist *H);
+
+// Evaluate g(h(k)) for every k in [0, 2^(n-3)) and store it as float in
+// out[k]. Each thread fills one contiguous range of out. If H != NULL the
+// histogram is accumulated as well (per-thread, merged at the end).
+// Returns 1 on success, 0 on failure.
+int landscape_fill_omp(const Instance *I, float *out, LandscapeHist *H,
+                       LandscapeStats *S);
+
+// Same as landscape_fill_omp(), writing into a memory-mapped file at path.
+// The file is (re)created with 2^(n-3) native-endian float32 values.
+// Returns 1 on success, 0 on failure (prints error to stderr).
+int landscape_dump_file(const Instance *I, const char *path, LandscapeHist *H,
+                        LandscapeStats *S);
+
+#endif // LANDSCAPE_H
@@ -6,4 +6,12 @@
 
 double score_g_no_sqrt(const Instance *I, const Vec3 *x);
 
+// Prefix pruning test. Accumulates g over the edges in completion order
+// (I->E sorted by max(u,v), see instance_precompute) and returns the vertex
+// L at which the partial sum first exceeds delta: then every mask sharing
+// the bits of vertices 4..L fails too. Returns 0 if g <= delta (stored in
+// *g_out).
+int score_prune_level(const Instance *I, const Vec3 *x, double delta,
+                      double *g_out);
+
 #endif // SCORE_H
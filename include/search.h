@@ -1,18 +1,129 @@
 #ifndef SEARCH_H
 #define SEARCH_H
 
+#include <omp.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include "instance.h"
+#include "mat4.h"
+
+// Enumeration orders over masks (used by the portfolio search).
+typedef enum {
+    SEARCH_ORDER_ASC = 0, // k = 0, 1, 2, ... (late vertices vary first)
+    SEARCH_ORDER_DESC,    // k = total-1, total-2, ...
+    SEARCH_ORDER_BITREV,  // bit-reversed counter (early vertices vary first)
+    SEARCH_ORDER_RANGES,  // chunks visited in a seeded random permutation
+    SEARCH_ORDER_BITPERM, // counter bits scattered by a seeded vertex order
+    SEARCH_ORDER_COUNT
+} SearchOrder;
+
+typedef enum {
+    SEARCH_MODE_FIRST = 0, // ascending scan (search_first_k_ctx)
+    SEARCH_MODE_PORTFOLIO  // racing orders (search_portfolio_ctx)
+} SearchMode;
 
 typedef struct {
     int found;          // 1 if found
     uint64_t k;         // valid k
     double g;           // g(h(k))
+    uint64_t evaluated; // number of masks scored
+    int cancelled;      // 1 if cancelled or stopped by progress first
+    int order;          // SearchOrder that produced k
 } SearchResult;
 
+typedef struct {
+    int mode;                // SearchMode
+    double delta;            // accept masks with g <= delta
+    uint64_t seed;           // random orders of SEARCH_MODE_PORTFOLIO
+    uint64_t progress_every; // masks between progress callbacks (0 = off)
+} SearchConfig;
+
+// Called with the number of masks evaluated so far (out of total).
+// Return nonzero to stop this run (it returns cancelled=1); later runs on
+// the same context are not affected.
+typedef int (*SearchProgressFn)(void *user, uint64_t evaluated,
+                                uint64_t total);
+
+// Called for each mask with g <= delta. Return nonzero to accept it (the
+// search stops and returns it), 0 to reject it and keep searching.
+typedef int (*SearchHitFn)(void *user, uint64_t k, double g);
+
+// Reusable search state: per-thread scratch and callbacks. One context
+// runs one search at a time; use one context per concurrent search.
+// Callbacks are invoked from worker threads, one at a time per context.
+typedef struct {
+    int nthreads; // OpenMP threads per search
+    int max_n;    // scratch capacity (vertices)
+    Vec3 **x;     // x[t]: points scratch of thread t, length max_n + 1
+
+    atomic_int cancel; // set by search_ctx_cancel(), cleared by _clear
+    atomic_int stop;   // current run only: cancel or progress stop
+
+    // Serializes result publishing and callbacks within this context only,
+    // so concurrent contexts never wait on each other.
+    omp_lock_t lock;
+
+    SearchProgressFn progress;
+    SearchHitFn hit;
+    void *user;
+
+    // Per-run counters
+    atomic_uint_fast64_t evaluated;
+    atomic_uint_fast64_t next_report;
+    uint64_t total;
+    uint64_t progress_every;
+} SearchContext;
+
+// Allocate per-thread scratch for instances with up to max_n vertices
+// (grown on demand). nthreads <= 0 uses omp_get_max_threads().
+// Returns 1 on success, 0 on failure.
+int search_ctx_init(SearchContext *C, int nthreads, int max_n);
+
+// Free scratch and the context lock.
+void search_ctx_free(SearchContext *C);
+
+// Install callbacks (any may be NULL).
+void search_ctx_set_callbacks(SearchContext *C, SearchProgressFn progress,
+                              SearchHitFn hit, void *user);
+
+// Ask a running (or the next) search to stop. Safe from any thread.
+// The flag stays set until search_ctx_clear_cancel().
+void search_ctx_cancel(SearchContext *C);
+void search_ctx_clear_cancel(SearchContext *C);
+
+// Run one search on I according to cfg (dispatches on cfg->mode).
+// A cancelled search that found nothing returns found=0, cancelled=1.
+SearchResult search_ctx_run(SearchContext *C, const Instance *I,
+                            const SearchConfig *cfg);
+
+// Mode-specific kernels behind search_ctx_run(). Require I->n <= C->max_n.
+SearchResult search_first_k_ctx(SearchContext *C, const Instance *I,
+                                const SearchConfig *cfg);
+SearchResult search_portfolio_ctx(SearchContext *C, const Instance *I,
+                                  const SearchConfig *cfg);
+
+// Kernel helpers: account n more evaluated masks (and call progress);
+// returns nonzero if the search should stop. search_ctx_hit() calls the
+// hit callback; returns 1 if the mask is accepted. The caller must hold
+// C->lock, so that checking and publishing the result is atomic.
+int search_ctx_report(SearchContext *C, uint64_t n);
+int search_ctx_hit(SearchContext *C, uint64_t k, double g);
+
 // Find the smallest k in [0, 2^(n-3)) such that score <= delta.
 // Returns found=1 if exists, else found=0.
+// One-shot convenience wrapper (allocates a temporary context).
 SearchResult search_first_k_omp(const Instance *I, double delta);
 
-#endif // SEARCH_H
+// Portfolio search: the threads are split into groups that race different
+// enumeration orders (one SearchOrder per group; with fewer threads than
+// orders, each thread interleaves chunks of several orders). The first
+// mask with score <= delta ends the race. seed drives the random orders.
+// k is any solution, not necessarily the smallest.
+// One-shot convenience wrapper (allocates a temporary context).
+SearchResult search_portfolio_omp(const Instance *I, double delta,
+                                  uint64_t seed);
 
+// Short name of a SearchOrder ("asc", "desc", ...).
+const char *search_order_name(int order);
+
+#endif // SEARCH_H
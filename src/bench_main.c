@@ -0,0 +1,114 @@
+#include "instance.h"
+#include "search.h"
+
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Time-to-first-solution benchmark: single-order scan vs portfolio.
+
+typedef struct {
+    double sum, sum2, min, max;
+    int n, found;
+} Stat;
+
+static void stat_add(Stat *S, double t, int found) {
+    if (S->n == 0 || t < S->min)
+        S->min = t;
+    if (S->n == 0 || t > S->max)
+        S->max = t;
+    S->sum += t;
+    S->sum2 += t * t;
+    S->n++;
+    S->found += found;
+}
+
+static void stat_print(const char *name, const Stat *S) {
+    double mean = S->sum / S->n;
+    double var = S->sum2 / S->n - mean * mean;
+    if (var < 0.0)
+        var = 0.0;
+    printf("%-10s runs=%d found=%d  mean=%.6fs  stddev=%.6fs  "
+           "min=%.6fs  max=%.6fs\n",
+           name, S->n, S->found, mean, sqrt(var), S->min, S->max);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s [-r] <instance_file> <delta> [reps]\n",
+            prog);
+    fprintf(stderr, "example: %s data/20_134.in 1e-6 10\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *prog = argv[0];
+    int reorder = instance_take_reorder_flag(&argc, &argv);
+
+    if (argc < 3) {
+        usage(prog);
+        return 1;
+    }
+
+    const char *path = argv[1];
+    double delta = strtod(argv[2], NULL);
+    int reps = (argc > 3) ? atoi(argv[3]) : 5;
+    if (reps < 1) {
+        usage(prog);
+        return 1;
+    }
+
+    Instance I;
+    if (!instance_load(path, &I)) {
+        instance_free(&I);
+        return 1;
+    }
+    // Re-order (on request or if 1..n is invalid), validate, precompute
+    if (!instance_prepare(&I, reorder, NULL)) {
+        instance_free(&I);
+        return 1;
+    }
+
+    printf("threads=%d  reps=%d  delta=%.12g\n", omp_get_max_threads(), reps,
+           delta);
+    instance_print_order(&I, stdout);
+
+    // One context for all runs: scratch is allocated once, outside timing.
+    SearchContext C;
+    if (!search_ctx_init(&C, 0, I.n)) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        instance_free(&I);
+        return 1;
+    }
+
+    Stat single = {0}, port = {0};
+
+    for (int r = 0; r < reps; r++) {
+        SearchConfig cfg = {SEARCH_MODE_FIRST, delta, 0, 0};
+        double t0 = omp_get_wtime();
+        SearchResult A = search_ctx_run(&C, &I, &cfg);
+        double t1 = omp_get_wtime();
+        stat_add(&single, t1 - t0, A.found);
+        printf("rep %d  single     t=%.6fs  found=%d  k=%llu  evaluated=%llu\n",
+               r, t1 - t0, A.found, (unsigned long long)A.k,
+               (unsigned long long)A.evaluated);
+
+        cfg.mode = SEARCH_MODE_PORTFOLIO;
+        cfg.seed = (uint64_t)r + 1;
+        t0 = omp_get_wtime();
+        SearchResult B = search_ctx_run(&C, &I, &cfg);
+        t1 = omp_get_wtime();
+        stat_add(&port, t1 - t0, B.found);
+        printf("rep %d  portfolio  t=%.6fs  found=%d  k=%llu  evaluated=%llu  "
+               "order=%s\n",
+               r, t1 - t0, B.found, (unsigned long long)B.k,
+               (unsigned long long)B.evaluated, search_order_name(B.order));
+    }
+
+    printf("\n");
+    stat_print("single", &single);
+    stat_print("portfolio", &port);
+
+    search_ctx_free(&C);
+    instance_free(&I);
+    return 0;
+}
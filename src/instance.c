@@ -56,32 +56,35 @@ int instance_load(const char *path, Instance *I) {
         return 0;
     }
 
+    int ok = instance_load_stream(f, I);
+    fclose(f);
+    return ok;
+}
+
+int instance_load_stream(FILE *f, Instance *I) {
+    memset(I, 0, sizeof(*I));
+
     if (fscanf(f, "%d %d", &I->n, &I->m) != 2) {
         fprintf(stderr, "ERROR: failed to read 'n m' header\n");
-        fclose(f);
         return 0;
     }
     if (I->n < 4) {
         fprintf(stderr, "ERROR: n must be >= 4 (got %d)\n", I->n);
-        fclose(f);
         return 0;
     }
     if (I->m <= 0) {
         fprintf(stderr, "ERROR: m must be > 0 (got %d)\n", I->m);
-        fclose(f);
         return 0;
     }
 
     if (!alloc_mats(I)) {
         fprintf(stderr, "ERROR: out of memory allocating matrices\n");
-        fclose(f);
         return 0;
     }
 
     I->E = (Edge *)malloc((size_t)I->m * sizeof(Edge));
     if (!I->E) {
         fprintf(stderr, "ERROR: out of memory allocating edges\n");
-        fclose(f);
         return 0;
     }
 
@@ -90,20 +93,17 @@ int instance_load(const char *path, Instance *I) {
         double d;
         if (fscanf(f, "%d %d %lf", &a, &b, &d) != 3) {
             fprintf(stderr, "ERROR: failed to read edge line %d\n", e + 1);
-            fclose(f);
             return 0;
         }
         if (a < 1 || a > I->n || b < 1 || b > I->n || a == b) {
             fprintf(stderr, "ERROR: invalid edge (%d,%d) for n=%d\n", a, b,
                     I->n);
-            fclose(f);
             return 0;
         }
         if (!(d > 0.0)) {
             fprintf(stderr,
                     "ERROR: non-positive distance for edge (%d,%d): %g\n", a, b,
                     d);
-            fclose(f);
             return 0;
         }
 
@@ -116,7 +116,6 @@ int instance_load(const char *path, Instance *I) {
         set_d(I, b, a, d);
     }
 
-    fclose(f);
     return 1;
 }
 
@@ -155,9 +154,322 @@ int instance_validate_dmdgp(const Instance *I) {
     return ok;
 }
 
+static inline int order_at(const int *order, int p) {
+    return order ? order[p] : p;
+}
+
+int instance_check_order(const Instance *I, const int *order) {
+    int n = I->n;
+    for (int k = 3; k <= n; k++) {
+        int a = order_at(order, k - 2), b = order_at(order, k - 1),
+            c = order_at(order, k);
+        if (!has_d(I, a, b) || !has_d(I, b, c) || !has_d(I, a, c))
+            return 0;
+        if (k >= 4 && !has_d(I, order_at(order, k - 3), c))
+            return 0;
+    }
+    return 1;
+}
+
+// Sum of completion positions of the pruning edges for order[1..n].
+static long order_cost(const Instance *I, const int *order) {
+    int n = I->n;
+    int *pos = (int *)calloc((size_t)n + 1, sizeof(int));
+    if (!pos)
+        return -1;
+    for (int p = 1; p <= n; p++)
+        pos[order[p]] = p;
+
+    long cost = 0;
+    for (int e = 0; e < I->m; e++) {
+        int a = pos[I->E[e].u], b = pos[I->E[e].v];
+        int hi = a > b ? a : b, lo = a > b ? b : a;
+        if (hi - lo > 3)
+            cost += hi;
+    }
+    free(pos);
+    return cost;
+}
+
+// Total DFS nodes spent on the order search, and per starting triangle.
+#define ORDER_SEARCH_BUDGET 2000000L
+#define ORDER_START_BUDGET(n) (1024L * (n))
+
+typedef struct {
+    const Instance *I;
+    int *cur;           // cur[1..k-1] placed vertices
+    unsigned char *used;
+    int *cnt;           // cnt[v] = placed neighbours of v
+    int *deg;           // deg[v] = neighbours of v
+    int *cand;          // candidate buffer, n+1 per level
+    long budget;
+    long cost;          // partial cost of cur
+    long best;          // cost to beat (-1: none yet)
+} OrderSearch;
+
+static void order_place(OrderSearch *S, int v, int k) {
+    const Instance *I = S->I;
+    S->cur[k] = v;
+    S->used[v] = 1;
+    if (k >= 4)
+        S->cost += (long)k * (S->cnt[v] - 3);
+    for (int u = 1; u <= I->n; u++)
+        if (has_d(I, u, v))
+            S->cnt[u]++;
+}
+
+static void order_unplace(OrderSearch *S, int v, int k) {
+    const Instance *I = S->I;
+    for (int u = 1; u <= I->n; u++)
+        if (has_d(I, u, v))
+            S->cnt[u]--;
+    if (k >= 4)
+        S->cost -= (long)k * (S->cnt[v] - 3);
+    S->used[v] = 0;
+}
+
+// Forward check after placing cur[1..k-1]: every unplaced vertex will
+// need three predecessors, which can only be unplaced vertices or the
+// last three placed ones.
+static int order_feasible(const OrderSearch *S, int k) {
+    const Instance *I = S->I;
+    int a = S->cur[k - 3], b = S->cur[k - 2], c = S->cur[k - 1];
+    for (int u = 1; u <= I->n; u++) {
+        if (S->used[u])
+            continue;
+        int usable = S->deg[u] - S->cnt[u] + has_d(I, u, a) +
+                     has_d(I, u, b) + has_d(I, u, c);
+        if (usable < 3)
+            return 0;
+    }
+    return 1;
+}
+
+// Greedy depth-first extension of cur[1..k-1]: the next vertex must see
+// the last three placed ones; prefer the one closing most pruning edges,
+// then the one with fewest free neighbours left (most constrained).
+static int order_dfs(OrderSearch *S, int k) {
+    const Instance *I = S->I;
+    int n = I->n;
+    if (k > n)
+        return 1;
+    if (--S->budget < 0)
+        return 0;
+    if (S->best >= 0 && S->cost >= S->best)
+        return 0;
+    if (!order_feasible(S, k))
+        return 0;
+
+    int *cand = S->cand + (size_t)k * (size_t)(n + 1);
+    int nc = 0;
+    int a = S->cur[k - 3], b = S->cur[k - 2], c = S->cur[k - 1];
+    for (int v = 1; v <= n; v++) {
+        if (S->used[v] || !has_d(I, v, a) || !has_d(I, v, b) ||
+            !has_d(I, v, c))
+            continue;
+        // insertion sort: cnt desc, free neighbours asc, id asc
+        int j = nc++;
+        while (j > 0 &&
+               (S->cnt[cand[j - 1]] < S->cnt[v] ||
+                (S->cnt[cand[j - 1]] == S->cnt[v] &&
+                 S->deg[cand[j - 1]] - S->cnt[cand[j - 1]] >
+                     S->deg[v] - S->cnt[v]))) {
+            cand[j] = cand[j - 1];
+            j--;
+        }
+        cand[j] = v;
+    }
+
+    for (int i = 0; i < nc; i++) {
+        order_place(S, cand[i], k);
+        if (order_dfs(S, k + 1))
+            return 1;
+        order_unplace(S, cand[i], k);
+        if (S->budget < 0)
+            return 0;
+    }
+    return 0;
+}
+
+int instance_find_order(const Instance *I, int *order) {
+    int n = I->n;
+    long best = -1;
+
+    if (instance_check_order(I, NULL)) {
+        for (int p = 1; p <= n; p++)
+            order[p] = p;
+        best = order_cost(I, order);
+    }
+
+    OrderSearch S;
+    memset(&S, 0, sizeof(S));
+    S.I = I;
+    S.cur = (int *)calloc((size_t)n + 1, sizeof(int));
+    S.used = (unsigned char *)calloc((size_t)n + 1, 1);
+    S.cnt = (int *)calloc((size_t)n + 1, sizeof(int));
+    S.deg = (int *)calloc((size_t)n + 1, sizeof(int));
+    S.cand = (int *)calloc((size_t)(n + 2) * (size_t)(n + 1), sizeof(int));
+    // by_deg[0..n-1]: vertices by ascending degree (start triangle order)
+    int *by_deg = (int *)calloc((size_t)n, sizeof(int));
+    if (!S.cur || !S.used || !S.cnt || !S.deg || !S.cand || !by_deg) {
+        free(S.cur);
+        free(S.used);
+        free(S.cnt);
+        free(S.deg);
+        free(S.cand);
+        free(by_deg);
+        return best >= 0;
+    }
+
+    for (int u = 1; u <= n; u++)
+        for (int v = 1; v <= n; v++)
+            S.deg[u] += has_d(I, u, v);
+
+    // Low-degree vertices can only sit near either end of a valid order
+    // (a degree-3 vertex must be first or last), and any valid order
+    // reversed is valid too, so try starting from them first.
+    for (int v = 1; v <= n; v++) {
+        int j = v - 1;
+        while (j > 0 && S.deg[by_deg[j - 1]] > S.deg[v]) {
+            by_deg[j] = by_deg[j - 1];
+            j--;
+        }
+        by_deg[j] = v;
+    }
+
+    long total = ORDER_SEARCH_BUDGET;
+    for (int ia = 0; ia < n && total > 0; ia++) {
+        int a = by_deg[ia];
+        for (int ib = 0; ib < n && total > 0; ib++) {
+            int b = by_deg[ib];
+            if (b == a || !has_d(I, a, b))
+                continue;
+            for (int ic = 0; ic < n && total > 0; ic++) {
+                int c = by_deg[ic];
+                if (c == a || c == b || !has_d(I, a, c) || !has_d(I, b, c))
+                    continue;
+
+                S.cost = 0;
+                S.best = best;
+                S.budget = ORDER_START_BUDGET(n);
+                if (S.budget > total)
+                    S.budget = total;
+                long start = S.budget;
+
+                order_place(&S, a, 1);
+                order_place(&S, b, 2);
+                order_place(&S, c, 3);
+                if (order_dfs(&S, 4) && (best < 0 || S.cost < best)) {
+                    best = S.cost;
+                    memcpy(order, S.cur, ((size_t)n + 1) * sizeof(int));
+                }
+                total -= start - (S.budget > 0 ? S.budget : 0);
+
+                memset(S.used, 0, (size_t)n + 1);
+                memset(S.cnt, 0, ((size_t)n + 1) * sizeof(int));
+            }
+        }
+    }
+
+    free(S.cur);
+    free(S.used);
+    free(S.cnt);
+    free(S.deg);
+    free(S.cand);
+    free(by_deg);
+    return best >= 0;
+}
+
+int instance_remap(Instance *I, const int *order) {
+    int n = I->n;
+    size_t sz = (size_t)(n + 1) * (size_t)(n + 1);
+
+    int *pos = (int *)calloc((size_t)n + 1, sizeof(int));
+    int *orig = (int *)calloc((size_t)n + 1, sizeof(int));
+    double *dist = (double *)calloc(sz, sizeof(double));
+    unsigned char *has = (unsigned char *)calloc(sz, sizeof(unsigned char));
+    if (!pos || !orig || !dist || !has) {
+        free(pos);
+        free(orig);
+        free(dist);
+        free(has);
+        return 0;
+    }
+
+    for (int p = 1; p <= n; p++) {
+        pos[order[p]] = p;
+        // compose with an earlier remap, if any
+        orig[p] = I->orig ? I->orig[order[p]] : order[p];
+    }
+
+    for (int e = 0; e < I->m; e++) {
+        I->E[e].u = pos[I->E[e].u];
+        I->E[e].v = pos[I->E[e].v];
+    }
+    for (int a = 1; a <= n; a++) {
+        for (int b = 1; b <= n; b++) {
+            dist[IDX(n, pos[a], pos[b])] = I->dist[IDX(n, a, b)];
+            has[IDX(n, pos[a], pos[b])] = I->has[IDX(n, a, b)];
+        }
+    }
+
+    free(I->dist);
+    free(I->has);
+    free(I->orig);
+    I->dist = dist;
+    I->has = has;
+    I->orig = orig;
+    free(pos);
+    return 1;
+}
+
+int instance_reorder(Instance *I) {
+    int *order = (int *)calloc((size_t)I->n + 1, sizeof(int));
+    if (!order) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        return 0;
+    }
+    if (!instance_find_order(I, order)) {
+        fprintf(stderr, "ERROR: no valid DMDGP vertex order found\n");
+        free(order);
+        return 0;
+    }
+    int ok = instance_remap(I, order);
+    if (!ok)
+        fprintf(stderr, "ERROR: out of memory remapping vertices\n");
+    free(order);
+    return ok;
+}
+
+void instance_print_order(const Instance *I, FILE *f) {
+    if (!I->orig)
+        return;
+    fprintf(f, "VERTEX ORDER:");
+    for (int i = 1; i <= I->n; i++)
+        fprintf(f, " %d", I->orig[i]);
+    fprintf(f, "\n");
+}
+
+void instance_points_to_original(const Instance *I, const Vec3 *x, Vec3 *y) {
+    for (int i = 1; i <= I->n; i++)
+        y[I->orig ? I->orig[i] : i] = x[i];
+}
+
+static int edge_level_cmp(const void *pa, const void *pb) {
+    const Edge *a = (const Edge *)pa, *b = (const Edge *)pb;
+    int la = a->u > a->v ? a->u : a->v, lb = b->u > b->v ? b->u : b->v;
+    if (la != lb)
+        return la < lb ? -1 : 1;
+    int sa = a->u + a->v, sb = b->u + b->v;
+    return (sa > sb) - (sa < sb);
+}
+
 int instance_precompute(Instance *I) {
     int n = I->n;
 
+    // Edges ordered by the vertex that completes them (see score.h)
+    qsort(I->E, (size_t)I->m, sizeof(Edge), edge_level_cmp);
+
     for (int k = 2; k <= n; k++) {
         I->bond[k] = get_d(I, k - 1, k);
     }
@@ -262,6 +574,33 @@ int instance_precompute(Instance *I) {
     return 1;
 }
 
+int instance_prepare(Instance *I, int force_reorder, const char **why) {
+    const char *reason = NULL;
+    if ((force_reorder || !instance_check_order(I, NULL)) &&
+        !instance_reorder(I)) {
+        reason = "no_vertex_order";
+    } else if (!instance_validate_dmdgp(I)) {
+        fprintf(stderr, "ERROR: instance is not a DMDGP for its vertex order. "
+                        "Aborting.\n");
+        reason = "not_dmdgp";
+    } else if (!instance_precompute(I)) {
+        fprintf(stderr, "ERROR: precompute failed.\n");
+        reason = "precompute_failed";
+    }
+    if (why)
+        *why = reason;
+    return reason == NULL;
+}
+
+int instance_take_reorder_flag(int *argc, char ***argv) {
+    if (*argc < 2 || strcmp((*argv)[1], "-r") != 0)
+        return 0;
+    (*argv)[1] = (*argv)[0];
+    (*argc)--;
+    (*argv)++;
+    return 1;
+}
+
 void instance_free(Instance *I) {
     if (!I)
         return;
@@ -276,5 +615,6 @@ void instance_free(Instance *I) {
     free(I->bond);
     free(I->A_plus);
     free(I->A_minus);
+    free(I->orig);
     memset(I, 0, sizeof(*I));
 }
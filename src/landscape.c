@@ -0,0 +1,205 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "landscape.h"
+#include "geom.h"
+#include "score.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+int landscape_hist_init(LandscapeHist *H, double log10_min, double log10_max,
+                        int per_decade) {
+    memset(H, 0, sizeof(*H));
+    if (per_decade <= 0 || !(log10_max > log10_min))
+        return 0;
+
+    int nbins = (int)ceil((log10_max - log10_min) * per_decade);
+    H->count = (uint64_t *)calloc((size_t)nbins, sizeof(uint64_t));
+    if (!H->count)
+        return 0;
+
+    H->per_decade = per_decade;
+    H->nbins = nbins;
+    H->log10_min = log10_min;
+    return 1;
+}
+
+void landscape_hist_free(LandscapeHist *H) {
+    if (!H)
+        return;
+    free(H->count);
+    memset(H, 0, sizeof(*H));
+}
+
+// Bin index for g: -1 = underflow, nbins = overflow.
+static inline int hist_bin(const LandscapeHist *H, double g) {
+    if (!(g > 0.0))
+        return isnan(g) ? H->nbins : -1;
+    double b = floor((log10(g) - H->log10_min) * H->per_decade);
+    if (b < 0.0)
+        return -1;
+    if (!(b < (double)H->nbins))
+        return H->nbins;
+    return (int)b;
+}
+
+int landscape_fill_omp(const Instance *I, float *out, LandscapeHist *H,
+                       LandscapeStats *S) {
+    const int n = I->n;
+    const int m_bits = n - 3;
+    if (m_bits <= 0 || m_bits >= 63)
+        return 0;
+
+    const uint64_t total = 1ULL << m_bits;
+
+    if (H) {
+        memset(H->count, 0, (size_t)H->nbins * sizeof(uint64_t));
+        H->underflow = 0;
+        H->overflow = 0;
+    }
+
+    int ok = 1;
+    uint64_t best_k = 0;
+    double best_g = INFINITY;
+
+    // Guards the merge of per-thread minima and histograms (local, so
+    // concurrent calls do not serialize on each other)
+    omp_lock_t merge;
+    omp_init_lock(&merge);
+
+#pragma omp parallel
+    {
+        const uint64_t nth = (uint64_t)omp_get_num_threads();
+        const uint64_t tid = (uint64_t)omp_get_thread_num();
+
+        // Disjoint contiguous range per thread: each thread only touches
+        // its own pages of the output.
+        const uint64_t q = total / nth, r = total % nth;
+        const uint64_t k_begin = q * tid + (tid < r ? tid : r);
+        const uint64_t k_end = k_begin + q + (tid < r ? 1 : 0);
+
+        Vec3 *x = (Vec3 *)malloc(((size_t)n + 1) * sizeof(Vec3));
+        // bins [0..nbins-1], underflow at nbins, overflow at nbins+1
+        uint64_t *local = NULL;
+        if (H)
+            local =
+                (uint64_t *)calloc((size_t)H->nbins + 2, sizeof(uint64_t));
+
+        if (!x || (H && !local)) {
+#pragma omp atomic write
+            ok = 0;
+        } else {
+            uint64_t my_k = 0;
+            double my_g = INFINITY;
+
+            for (uint64_t k = k_begin; k < k_end; k++) {
+                geom_build_points_mat4(I, k, x);
+                double g = score_g_no_sqrt(I, x);
+
+                out[k] = (float)g;
+
+                if (g < my_g) {
+                    my_g = g;
+                    my_k = k;
+                }
+                if (local) {
+                    int b = hist_bin(H, g);
+                    if (b < 0)
+                        b = H->nbins;
+                    else if (b == H->nbins)
+                        b = H->nbins + 1;
+                    local[b]++;
+                }
+            }
+
+            omp_set_lock(&merge);
+            if (my_g < best_g || (my_g == best_g && my_k < best_k)) {
+                best_g = my_g;
+                best_k = my_k;
+            }
+            if (local) {
+                for (int b = 0; b < H->nbins; b++)
+                    H->count[b] += local[b];
+                H->underflow += local[H->nbins];
+                H->overflow += local[H->nbins + 1];
+            }
+            omp_unset_lock(&merge);
+        }
+
+        free(local);
+        free(x);
+    }
+
+    omp_destroy_lock(&merge);
+
+    if (S) {
+        S->total = total;
+        S->k_min = best_k;
+        S->g_min = best_g;
+    }
+
+    return ok;
+}
+
+int landscape_dump_file(const Instance *I, const char *path, LandscapeHist *H,
+                        LandscapeStats *S) {
+    const int m_bits = I->n - 3;
+    if (m_bits <= 0 || m_bits >= 63 ||
+        (1ULL << m_bits) > (uint64_t)SIZE_MAX / sizeof(float)) {
+        fprintf(stderr, "ERROR: landscape too large for n=%d\n", I->n);
+        return 0;
+    }
+
+    const size_t len = (size_t)(1ULL << m_bits) * sizeof(float);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: cannot open output file: %s (%s)\n", path,
+                strerror(errno));
+        return 0;
+    }
+
+    // Reserve the blocks up front so a full disk fails here instead of
+    // raising SIGBUS while writing through the mapping.
+    int rc = posix_fallocate(fd, 0, (off_t)len);
+    if (rc == EINVAL || rc == EOPNOTSUPP)
+        rc = ftruncate(fd, (off_t)len) == 0 ? 0 : errno;
+    if (rc != 0) {
+        fprintf(stderr, "ERROR: cannot size output file to %zu bytes (%s)\n",
+                len, strerror(rc));
+        close(fd);
+        return 0;
+    }
+
+    float *out = (float *)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                               fd, 0);
+    if (out == MAP_FAILED) {
+        fprintf(stderr, "ERROR: mmap of %zu bytes failed (%s)\n", len,
+                strerror(errno));
+        close(fd);
+        return 0;
+    }
+
+    int ok = landscape_fill_omp(I, out, H, S);
+    if (!ok)
+        fprintf(stderr, "ERROR: out of memory in landscape workers\n");
+
+    if (msync(out, len, MS_SYNC) != 0) {
+        fprintf(stderr, "ERROR: msync failed (%s)\n", strerror(errno));
+        ok = 0;
+    }
+    munmap(out, len);
+    if (close(fd) != 0) {
+        fprintf(stderr, "ERROR: close failed (%s)\n", strerror(errno));
+        ok = 0;
+    }
+
+    return ok;
+}
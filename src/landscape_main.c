@@ -0,0 +1,89 @@
+#include "instance.h"
+#include "landscape.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Histogram range (in decades of g)
+#define HIST_LOG10_MIN (-20.0)
+#define HIST_LOG10_MAX (20.0)
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "usage: %s [-r] <instance_file> <out_file> "
+            "[hist_bins_per_decade]\n",
+            prog);
+    fprintf(stderr, "example: %s data/20_134.in build/20_134.f32 4\n", prog);
+}
+
+static void print_hist(const LandscapeHist *H) {
+    printf("\nHistogram of log10(g) (%d bins/decade):\n", H->per_decade);
+    printf("< %.3g  %llu\n", pow(10.0, H->log10_min),
+           (unsigned long long)H->underflow);
+    for (int b = 0; b < H->nbins; b++) {
+        if (!H->count[b])
+            continue;
+        double lo = H->log10_min + (double)b / H->per_decade;
+        double hi = H->log10_min + (double)(b + 1) / H->per_decade;
+        printf("[%.3g, %.3g)  %llu\n", pow(10.0, lo), pow(10.0, hi),
+               (unsigned long long)H->count[b]);
+    }
+    printf(">= %.3g  %llu\n",
+           pow(10.0, H->log10_min + (double)H->nbins / H->per_decade),
+           (unsigned long long)H->overflow);
+}
+
+int main(int argc, char **argv) {
+    const char *prog = argv[0];
+    int reorder = instance_take_reorder_flag(&argc, &argv);
+
+    if (argc < 3) {
+        usage(prog);
+        return 1;
+    }
+
+    const char *path = argv[1];
+    const char *out_path = argv[2];
+    int per_decade = (argc > 3) ? atoi(argv[3]) : 0;
+
+    Instance I;
+    if (!instance_load(path, &I)) {
+        instance_free(&I);
+        return 1;
+    }
+    // Re-order (on request or if 1..n is invalid), validate, precompute
+    if (!instance_prepare(&I, reorder, NULL)) {
+        instance_free(&I);
+        return 1;
+    }
+
+    LandscapeHist H;
+    LandscapeHist *Hp = NULL;
+    if (per_decade > 0) {
+        if (!landscape_hist_init(&H, HIST_LOG10_MIN, HIST_LOG10_MAX,
+                                 per_decade)) {
+            fprintf(stderr, "ERROR: out of memory allocating histogram\n");
+            instance_free(&I);
+            return 1;
+        }
+        Hp = &H;
+    }
+
+    LandscapeStats S;
+    int ok = landscape_dump_file(&I, out_path, Hp, &S);
+
+    if (ok) {
+        printf("WROTE: %llu floats to %s\n", (unsigned long long)S.total,
+               out_path);
+        printf("MIN: k=%llu  g=%.12g\n", (unsigned long long)S.k_min, S.g_min);
+        instance_print_order(&I, stdout);
+        if (Hp)
+            print_hist(Hp);
+    }
+
+    if (Hp)
+        landscape_hist_free(Hp);
+    instance_free(&I);
+    return ok ? 0 : 1;
+}
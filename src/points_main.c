@@ -10,8 +10,12 @@ static void print_points(const Instance *I, const Vec3 *x) {
 }
 
 int main(int argc, char **argv) {
+    const char *prog = argv[0];
+    int reorder = instance_take_reorder_flag(&argc, &argv);
+
     if (argc < 3) {
-        fprintf(stderr, "usage: %s <instance_file> <k_decimal>\n", argv[0]);
+        fprintf(stderr, "usage: %s [-r] <instance_file> <k_decimal>\n",
+                prog);
         return 1;
     }
 
@@ -23,29 +27,29 @@ int main(int argc, char **argv) {
         instance_free(&I);
         return 1;
     }
-    if (!instance_validate_dmdgp(&I)) {
-        fprintf(stderr, "ERROR: instance is not a DMDGP for vertex order 1..n. "
-                        "Aborting.\n");
-        instance_free(&I);
-        return 1;
-    }
-    if (!instance_precompute(&I)) {
-        fprintf(stderr, "ERROR: precompute failed.\n");
+    // Re-order (on request or if 1..n is invalid), validate, precompute
+    if (!instance_prepare(&I, reorder, NULL)) {
         instance_free(&I);
         return 1;
     }
 
     Vec3 *x = (Vec3 *)calloc((size_t)I.n + 1, sizeof(Vec3));
-    if (!x) {
+    Vec3 *y = (Vec3 *)calloc((size_t)I.n + 1, sizeof(Vec3));
+    if (!x || !y) {
         fprintf(stderr, "ERROR: out of memory\n");
+        free(x);
+        free(y);
         instance_free(&I);
         return 1;
     }
 
+    // Points are printed with the original vertex ids
     geom_build_points_mat4(&I, k, x);
-    print_points(&I, x);
+    instance_points_to_original(&I, x, y);
+    print_points(&I, y);
 
     free(x);
+    free(y);
     instance_free(&I);
     return 0;
 }
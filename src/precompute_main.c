@@ -5,6 +5,7 @@ static void dump_precompute(const Instance *I) {
     int n = I->n;
 
     printf("n=%d m=%d\n", I->n, I->m);
+    instance_print_order(I, stdout);
 
     printf("\n Bond lengths (k=2..n):\n");
     for (int k = 2; k <= n; k++) {
@@ -24,8 +25,11 @@ static void dump_precompute(const Instance *I) {
 }
 
 int main(int argc, char **argv) {
+    const char *prog = argv[0];
+    int reorder = instance_take_reorder_flag(&argc, &argv);
+
     if (argc < 2) {
-        fprintf(stderr, "usage: %s <instance_file>\n", argv[0]);
+        fprintf(stderr, "usage: %s [-r] <instance_file>\n", prog);
         return 1;
     }
 
@@ -37,15 +41,8 @@ int main(int argc, char **argv) {
         return 1;
     }
 
-    if (!instance_validate_dmdgp(&I)) {
-        fprintf(stderr, "ERROR: instance is not a DMDGP for vertex order 1..n. "
-                        "Aborting.\n");
-        instance_free(&I);
-        return 1;
-    }
-
-    if (!instance_precompute(&I)) {
-        fprintf(stderr, "ERROR: precompute failed (numerical issue).\n");
+    // Re-order (on request or if 1..n is invalid), validate, precompute
+    if (!instance_prepare(&I, reorder, NULL)) {
         instance_free(&I);
         return 1;
     }
@@ -0,0 +1,124 @@
+#include "search.h"
+
+#include <omp.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int alloc_scratch(SearchContext *C, int max_n) {
+    for (int t = 0; t < C->nthreads; t++) {
+        Vec3 *p =
+            (Vec3 *)realloc(C->x[t], ((size_t)max_n + 1) * sizeof(Vec3));
+        if (!p)
+            return 0;
+        C->x[t] = p;
+    }
+    C->max_n = max_n;
+    return 1;
+}
+
+int search_ctx_init(SearchContext *C, int nthreads, int max_n) {
+    memset(C, 0, sizeof(*C));
+    atomic_init(&C->cancel, 0);
+    atomic_init(&C->stop, 0);
+    atomic_init(&C->evaluated, 0);
+    atomic_init(&C->next_report, 0);
+    omp_init_lock(&C->lock);
+
+    C->nthreads = (nthreads > 0) ? nthreads : omp_get_max_threads();
+    C->x = (Vec3 **)calloc((size_t)C->nthreads, sizeof(Vec3 *));
+    if (!C->x)
+        return 0;
+
+    return alloc_scratch(C, max_n > 0 ? max_n : 0);
+}
+
+void search_ctx_free(SearchContext *C) {
+    if (!C)
+        return;
+    if (C->x) {
+        for (int t = 0; t < C->nthreads; t++)
+            free(C->x[t]);
+        free(C->x);
+    }
+    omp_destroy_lock(&C->lock);
+    memset(C, 0, sizeof(*C));
+}
+
+void search_ctx_set_callbacks(SearchContext *C, SearchProgressFn progress,
+                              SearchHitFn hit, void *user) {
+    C->progress = progress;
+    C->hit = hit;
+    C->user = user;
+}
+
+void search_ctx_cancel(SearchContext *C) {
+    atomic_store(&C->cancel, 1);
+    atomic_store(&C->stop, 1);
+}
+
+void search_ctx_clear_cancel(SearchContext *C) {
+    atomic_store_explicit(&C->cancel, 0, memory_order_relaxed);
+}
+
+int search_ctx_report(SearchContext *C, uint64_t n) {
+    uint64_t done =
+        atomic_fetch_add_explicit(&C->evaluated, n, memory_order_relaxed) + n;
+
+    if (C->progress && C->progress_every) {
+        uint64_t due =
+            atomic_load_explicit(&C->next_report, memory_order_relaxed);
+        // Only the thread that moves next_report forward reports.
+        if (done >= due &&
+            atomic_compare_exchange_strong(
+                &C->next_report, &due,
+                (done / C->progress_every + 1) * C->progress_every)) {
+            omp_set_lock(&C->lock);
+            int stop = C->progress(C->user, done, C->total);
+            omp_unset_lock(&C->lock);
+            if (stop)
+                atomic_store(&C->stop, 1); // this run only
+        }
+    }
+
+    return atomic_load_explicit(&C->stop, memory_order_relaxed);
+}
+
+int search_ctx_hit(SearchContext *C, uint64_t k, double g) {
+    if (!C->hit)
+        return 1;
+    return C->hit(C->user, k, g);
+}
+
+SearchResult search_ctx_run(SearchContext *C, const Instance *I,
+                            const SearchConfig *cfg) {
+    SearchResult R = {0, 0, 0.0, 0, 0, SEARCH_ORDER_ASC};
+
+    const int m_bits = I->n - 3;
+    if (m_bits <= 0 || m_bits >= 63)
+        return R;
+
+    // Reuse the scratch unless this instance is larger than any before.
+    if (I->n > C->max_n && !alloc_scratch(C, I->n))
+        return R;
+
+    C->total = 1ULL << m_bits;
+    C->progress_every = cfg->progress_every;
+    atomic_store(&C->evaluated, 0);
+    atomic_store(&C->next_report, cfg->progress_every);
+    // A progress stop ends one run; a pending external cancel still
+    // applies (cancel sets both flags, so none is lost in between).
+    atomic_store(&C->stop, 0);
+    if (atomic_load(&C->cancel))
+        atomic_store(&C->stop, 1);
+
+    if (cfg->mode == SEARCH_MODE_PORTFOLIO)
+        R = search_portfolio_ctx(C, I, cfg);
+    else
+        R = search_first_k_ctx(C, I, cfg);
+
+    R.evaluated = atomic_load(&C->evaluated);
+    if (!R.found && atomic_load(&C->stop))
+        R.cancelled = 1;
+    return R;
+}
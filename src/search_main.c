@@ -4,39 +4,49 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 static void usage(const char *prog) {
-    fprintf(stderr, "usage: %s <instance_file> <delta>\n", prog);
+    fprintf(stderr,
+            "usage: %s [-r] <instance_file> <delta> [first|portfolio] "
+            "[seed]\n",
+            prog);
     fprintf(stderr, "example: %s data/7_18.in 1e-4\n", prog);
 }
 
 int main(int argc, char **argv) {
+    const char *prog = argv[0];
+    int reorder = instance_take_reorder_flag(&argc, &argv);
+
     if (argc < 3) {
-        usage(argv[0]);
+        usage(prog);
         return 1;
     }
 
     const char *path = argv[1];
     double delta = strtod(argv[2], NULL);
+    const char *mode = (argc > 3) ? argv[3] : "first";
+    uint64_t seed = (argc > 4) ? (uint64_t)strtoull(argv[4], NULL, 10) : 1;
 
-    Instance I;
-    if (!instance_load(path, &I)) {
-        instance_free(&I);
+    int portfolio = (strcmp(mode, "portfolio") == 0);
+    if (!portfolio && strcmp(mode, "first") != 0) {
+        usage(prog);
         return 1;
     }
-    if (!instance_validate_dmdgp(&I)) {
-        fprintf(stderr, "ERROR: instance is not a DMDGP for vertex order 1..n. "
-                        "Aborting.\n");
+
+    Instance I;
+    if (!instance_load(path, &I)) {
         instance_free(&I);
         return 1;
     }
-    if (!instance_precompute(&I)) {
-        fprintf(stderr, "ERROR: precompute failed.\n");
+    // Re-order (on request or if 1..n is invalid), validate, precompute
+    if (!instance_prepare(&I, reorder, NULL)) {
         instance_free(&I);
         return 1;
     }
 
-    SearchResult R = search_first_k_omp(&I, delta);
+    SearchResult R = portfolio ? search_portfolio_omp(&I, delta, seed)
+                               : search_first_k_omp(&I, delta);
 
     if (!R.found) {
         printf("NO SOLUTION: no k with g <= %.12g\n", delta);
@@ -46,6 +56,10 @@ int main(int argc, char **argv) {
 
     printf("FOUND: k=%llu  g=%.12g  (delta=%.12g)\n", (unsigned long long)R.k,
            R.g, delta);
+    instance_print_order(&I, stdout);
+    if (portfolio)
+        printf("ORDER: %s  evaluated=%llu\n", search_order_name(R.order),
+               (unsigned long long)R.evaluated);
 
     // print points for the found k (helps debugging)
     // Vec3 *x = calloc((size_t)I.n + 1, sizeof(Vec3));
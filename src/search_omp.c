@@ -6,56 +6,102 @@
 #include <stdatomic.h>
 #include <stdlib.h>
 
+// Masks per scheduling chunk
+#define SEARCH_CHUNK 1024
+
 SearchResult search_first_k_omp(const Instance *I, double delta) {
-    SearchResult R = {0, 0, 0.0};
+    SearchResult R = {0, 0, 0.0, 0, 0, SEARCH_ORDER_ASC};
+    SearchConfig cfg = {SEARCH_MODE_FIRST, delta, 0, 0};
+
+    SearchContext C;
+    if (search_ctx_init(&C, 0, I->n))
+        R = search_ctx_run(&C, I, &cfg);
+    search_ctx_free(&C);
+    return R;
+}
+
+SearchResult search_first_k_ctx(SearchContext *C, const Instance *I,
+                                const SearchConfig *cfg) {
+    SearchResult R = {0, 0, 0.0, 0, 0, SEARCH_ORDER_ASC};
 
     const int n = I->n;
     const int m_bits = n - 3;
-    if (m_bits <= 0 || m_bits >= 63)
+    if (m_bits <= 0 || m_bits >= 63 || n > C->max_n)
         return R;
 
+    const double delta = cfg->delta;
     const uint64_t total = 1ULL << m_bits;
+    const uint64_t nchunks = (total + SEARCH_CHUNK - 1) / SEARCH_CHUNK;
 
     // Shared "found" flag with atomic visibility
     atomic_int found;
     atomic_init(&found, 0);
 
-    // Shared result (written once under critical)
+    // Set when an edge among vertices 1..3 fails: no mask can succeed
+    atomic_int exhausted;
+    atomic_init(&exhausted, 0);
+
+    // Shared result (written once under C->lock)
     uint64_t found_k = 0;
     double found_g = 0.0;
 
-#pragma omp parallel
+#pragma omp parallel num_threads(C->nthreads)
     {
-        Vec3 *x = (Vec3 *)malloc(((size_t)n + 1) * sizeof(Vec3));
-        if (!x) {
-            // skip thread if allocation fails
-        } else {
-#pragma omp for schedule(dynamic, 1024)
-            for (uint64_t k = 0; k < total; k++) {
-
-                // If someone already found, stop doing work
-                if (atomic_load_explicit(&found, memory_order_relaxed)) {
-                    continue;
-                }
+        Vec3 *x = C->x[omp_get_thread_num()];
+
+#pragma omp for schedule(dynamic, 1)
+        for (uint64_t c = 0; c < nchunks; c++) {
+            uint64_t k = c * SEARCH_CHUNK;
+            const uint64_t k_end =
+                (total - k < SEARCH_CHUNK) ? total : k + SEARCH_CHUNK;
+            uint64_t my_evaluated = 0;
+
+            while (k < k_end) {
+                // If someone already found (or ruled out every mask), stop
+                if (atomic_load_explicit(&found, memory_order_relaxed) ||
+                    atomic_load_explicit(&exhausted, memory_order_relaxed))
+                    break;
+                // Same for a cancel or progress stop
+                if (atomic_load_explicit(&C->stop, memory_order_relaxed))
+                    break;
+
+                my_evaluated++;
 
                 geom_build_points_mat4(I, k, x);
-                double g = score_g_no_sqrt(I, x);
-
-                if (g <= delta) {
-// Publish exactly once
-#pragma omp critical
-                    {
-                        if (!atomic_load_explicit(&found,
-                                                  memory_order_relaxed)) {
-                            found_k = k;
-                            found_g = g;
-                            atomic_store_explicit(&found, 1,
-                                                  memory_order_relaxed);
-                        }
+                double g = 0.0;
+                int L = score_prune_level(I, x, delta, &g);
+
+                if (L == 0) {
+                    int accepted = 0;
+                    // Publish exactly once
+                    omp_set_lock(&C->lock);
+                    if (!atomic_load_explicit(&found, memory_order_relaxed) &&
+                        search_ctx_hit(C, k, g)) {
+                        found_k = k;
+                        found_g = g;
+                        atomic_store_explicit(&found, 1, memory_order_relaxed);
+                        accepted = 1;
                     }
+                    omp_unset_lock(&C->lock);
+                    if (accepted)
+                        break;
+                    k++; // rejected by the hit callback: keep going
+                    continue;
+                }
+
+                // Vertices 1..L are fixed by the bits of vertices 4..L
+                // (the high bits of k), so the whole subtree below this
+                // prefix fails: jump to the next prefix.
+                int low = n - L;
+                if (low >= m_bits) {
+                    atomic_store_explicit(&exhausted, 1,
+                                          memory_order_relaxed);
+                    break;
                 }
+                k = ((k >> low) + 1) << low;
             }
-            free(x);
+
+            search_ctx_report(C, my_evaluated);
         }
     }
 
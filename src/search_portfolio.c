@@ -0,0 +1,308 @@
+#include "geom.h"
+#include "score.h"
+#include "search.h"
+
+#include <omp.h>
+#include <stdatomic.h>
+
+// log2 of the number of consecutive counter values a thread takes at once
+#define PORTFOLIO_CHUNK_BITS 10
+
+// Rounds of the keyed chunk permutation used by SEARCH_ORDER_RANGES
+#define PORTFOLIO_RANGES_ROUNDS 3
+
+typedef struct {
+    int order;
+    // SEARCH_ORDER_RANGES: round keys (xor, odd multiplier) of the chunk
+    // permutation, see lane_chunk()
+    uint64_t key[PORTFOLIO_RANGES_ROUNDS], mul[PORTFOLIO_RANGES_ROUNDS];
+    int bit_to[64]; // SEARCH_ORDER_BITPERM: counter bit j -> mask bit
+} Lane;
+
+static uint64_t splitmix64(uint64_t *s) {
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+const char *search_order_name(int order) {
+    switch (order) {
+    case SEARCH_ORDER_ASC:
+        return "asc";
+    case SEARCH_ORDER_DESC:
+        return "desc";
+    case SEARCH_ORDER_BITREV:
+        return "bitrev";
+    case SEARCH_ORDER_RANGES:
+        return "ranges";
+    case SEARCH_ORDER_BITPERM:
+        return "bitperm";
+    default:
+        return "?";
+    }
+}
+
+static void lane_init(Lane *L, int order, int m_bits, uint64_t *rng) {
+    L->order = order;
+
+    for (int j = 0; j < PORTFOLIO_RANGES_ROUNDS; j++) {
+        L->key[j] = splitmix64(rng);
+        L->mul[j] = splitmix64(rng) | 1ULL; // odd: invertible mod 2^r
+    }
+
+    // Fisher-Yates over the m_bits vertex bits.
+    for (int j = 0; j < m_bits; j++)
+        L->bit_to[j] = j;
+    for (int j = m_bits - 1; j > 0; j--) {
+        int r = (int)(splitmix64(rng) % (uint64_t)(j + 1));
+        int t = L->bit_to[j];
+        L->bit_to[j] = L->bit_to[r];
+        L->bit_to[r] = t;
+    }
+}
+
+// Keyed permutation of the chunk indices [0, 2^r). Each round is a xor,
+// a multiply by an odd constant and a xorshift by s >= 1, all of which
+// are bijective mod 2^r, so the chunk order is a real shuffle rather
+// than a fixed stride.
+static inline uint64_t lane_chunk(const Lane *L, uint64_t c, int r) {
+    if (r == 0)
+        return 0;
+    const uint64_t mask = (1ULL << r) - 1ULL;
+    const int s = (r + 1) / 2;
+    for (int j = 0; j < PORTFOLIO_RANGES_ROUNDS; j++) {
+        c = ((c ^ L->key[j]) * L->mul[j]) & mask;
+        c ^= c >> s;
+    }
+    return c;
+}
+
+// Map the i-th counter value of a lane to a mask k in [0, 2^m_bits).
+static inline uint64_t lane_mask(const Lane *L, uint64_t i, int m_bits,
+                                 int chunk_bits) {
+    const uint64_t total_mask = (1ULL << m_bits) - 1ULL;
+
+    switch (L->order) {
+    case SEARCH_ORDER_DESC:
+        return total_mask - i;
+    case SEARCH_ORDER_BITREV: {
+        uint64_t k = 0;
+        for (int j = 0; j < m_bits; j++)
+            k |= ((i >> j) & 1ULL) << (m_bits - 1 - j);
+        return k;
+    }
+    case SEARCH_ORDER_RANGES: {
+        uint64_t c = lane_chunk(L, i >> chunk_bits, m_bits - chunk_bits);
+        return (c << chunk_bits) | (i & ((1ULL << chunk_bits) - 1ULL));
+    }
+    case SEARCH_ORDER_BITPERM: {
+        uint64_t k = 0;
+        for (int j = 0; j < m_bits; j++)
+            k |= ((i >> j) & 1ULL) << L->bit_to[j];
+        return k;
+    }
+    default:
+        return i;
+    }
+}
+
+// Next counter value after mask k = lane_mask(i) failed at vertex L, i.e.
+// every mask sharing its high m_bits - low bits (low = n - L) fails too.
+// Orders that keep such subtrees contiguous jump over them.
+static inline uint64_t lane_skip(const Lane *L, uint64_t i, uint64_t k,
+                                 int low, int chunk_bits) {
+    switch (L->order) {
+    case SEARCH_ORDER_ASC:
+        return ((i >> low) + 1) << low;
+    case SEARCH_ORDER_DESC:
+        return i + (k & ((1ULL << low) - 1ULL)) + 1;
+    case SEARCH_ORDER_RANGES: {
+        int b = (low < chunk_bits) ? low : chunk_bits; // stay in the chunk
+        return ((i >> b) + 1) << b;
+    }
+    default:
+        return i + 1;
+    }
+}
+
+SearchResult search_portfolio_omp(const Instance *I, double delta,
+                                  uint64_t seed) {
+    SearchResult R = {0, 0, 0.0, 0, 0, SEARCH_ORDER_ASC};
+    SearchConfig cfg = {SEARCH_MODE_PORTFOLIO, delta, seed, 0};
+
+    SearchContext C;
+    if (search_ctx_init(&C, 0, I->n))
+        R = search_ctx_run(&C, I, &cfg);
+    search_ctx_free(&C);
+    return R;
+}
+
+SearchResult search_portfolio_ctx(SearchContext *C, const Instance *I,
+                                  const SearchConfig *cfg) {
+    SearchResult R = {0, 0, 0.0, 0, 0, SEARCH_ORDER_ASC};
+
+    const int n = I->n;
+    const int m_bits = n - 3;
+    if (m_bits <= 0 || m_bits >= 63 || n > C->max_n)
+        return R;
+
+    const double delta = cfg->delta;
+    const uint64_t total = 1ULL << m_bits;
+    const int chunk_bits =
+        (m_bits < PORTFOLIO_CHUNK_BITS) ? m_bits : PORTFOLIO_CHUNK_BITS;
+    const uint64_t chunk = 1ULL << chunk_bits;
+    const uint64_t nchunks = total >> chunk_bits;
+
+    Lane lanes[SEARCH_ORDER_COUNT];
+    uint64_t rng = cfg->seed;
+    for (int l = 0; l < SEARCH_ORDER_COUNT; l++)
+        lane_init(&lanes[l], l, m_bits, &rng);
+
+    // Next chunk to hand out, and chunks fully scanned, per lane (shared
+    // by the lane's threads)
+    atomic_uint_fast64_t next[SEARCH_ORDER_COUNT];
+    atomic_uint_fast64_t done[SEARCH_ORDER_COUNT];
+    for (int l = 0; l < SEARCH_ORDER_COUNT; l++) {
+        atomic_init(&next[l], 0);
+        atomic_init(&done[l], 0);
+    }
+
+    // Shared "found" flag with atomic visibility
+    atomic_int found;
+    atomic_init(&found, 0);
+
+    // Set when no mask can succeed: an edge among vertices 1..3 fails, or
+    // some lane has scanned the whole mask space without a hit
+    atomic_int exhausted;
+    atomic_init(&exhausted, 0);
+
+    // Shared result (written once under C->lock)
+    uint64_t found_k = 0;
+    double found_g = 0.0;
+    int found_order = SEARCH_ORDER_ASC;
+
+#pragma omp parallel num_threads(C->nthreads)
+    {
+        const int nth = omp_get_num_threads();
+        const int tid = omp_get_thread_num();
+
+        // Lanes served by this thread: one group of threads per lane, or
+        // several lanes per thread when there are fewer threads than lanes.
+        int mine[SEARCH_ORDER_COUNT];
+        int nmine = 0;
+        for (int l = 0; l < SEARCH_ORDER_COUNT; l++) {
+            if (nth >= SEARCH_ORDER_COUNT ? (l == tid % SEARCH_ORDER_COUNT)
+                                          : (l % nth == tid))
+                mine[nmine++] = l;
+        }
+
+        Vec3 *x = C->x[tid];
+        uint64_t spent = 0; // evaluations in the current lane turn
+        int r = 0;
+
+        while (1) {
+            // Out of lanes: help the ones that still have chunks to hand
+            // out instead of idling until they finish.
+            if (nmine == 0) {
+                for (int l = 0; l < SEARCH_ORDER_COUNT; l++)
+                    if (atomic_load_explicit(&next[l], memory_order_relaxed) <
+                        nchunks)
+                        mine[nmine++] = l;
+                if (nmine == 0)
+                    break;
+                r = tid % nmine;
+                spent = 0;
+            }
+
+            if (atomic_load_explicit(&found, memory_order_relaxed) ||
+                atomic_load_explicit(&exhausted, memory_order_relaxed) ||
+                atomic_load_explicit(&C->stop, memory_order_relaxed))
+                break;
+
+            // Round-robin over this thread's lanes. A turn lasts about
+            // one chunk worth of evaluations, so lanes whose chunks are
+            // mostly pruned take several chunks per turn.
+            if (r >= nmine)
+                r = 0;
+            const int l = mine[r];
+            const Lane *L = &lanes[l];
+            uint64_t c =
+                atomic_fetch_add_explicit(&next[l], 1, memory_order_relaxed);
+            if (c >= nchunks) {
+                mine[r] = mine[--nmine]; // lane exhausted
+                spent = 0;
+                continue;
+            }
+
+            uint64_t i = c * chunk;
+            const uint64_t i_end = i + chunk;
+            uint64_t my_evaluated = 0;
+
+            while (i < i_end) {
+                if (atomic_load_explicit(&found, memory_order_relaxed) ||
+                    atomic_load_explicit(&exhausted, memory_order_relaxed) ||
+                    atomic_load_explicit(&C->stop, memory_order_relaxed))
+                    break;
+
+                uint64_t k = lane_mask(L, i, m_bits, chunk_bits);
+                my_evaluated++;
+
+                geom_build_points_mat4(I, k, x);
+                double g = 0.0;
+                int level = score_prune_level(I, x, delta, &g);
+
+                if (level == 0) {
+                    int accepted = 0;
+                    // Publish exactly once
+                    omp_set_lock(&C->lock);
+                    if (!atomic_load_explicit(&found, memory_order_relaxed) &&
+                        search_ctx_hit(C, k, g)) {
+                        found_k = k;
+                        found_g = g;
+                        found_order = L->order;
+                        atomic_store_explicit(&found, 1, memory_order_relaxed);
+                        accepted = 1;
+                    }
+                    omp_unset_lock(&C->lock);
+                    if (accepted)
+                        break;
+                    i++; // rejected by the hit callback: keep going
+                    continue;
+                }
+
+                int low = n - level;
+                if (low >= m_bits) {
+                    atomic_store_explicit(&exhausted, 1,
+                                          memory_order_relaxed);
+                    break;
+                }
+                i = lane_skip(L, i, k, low, chunk_bits);
+            }
+
+            // A lane that scanned every chunk saw every mask: no solution.
+            if (i >= i_end) {
+                uint64_t d = atomic_fetch_add_explicit(&done[l], 1,
+                                                       memory_order_relaxed);
+                if (d + 1 == nchunks)
+                    atomic_store_explicit(&exhausted, 1, memory_order_relaxed);
+            }
+
+            search_ctx_report(C, my_evaluated);
+            spent += my_evaluated;
+            if (spent >= chunk) {
+                spent = 0;
+                r++;
+            }
+        }
+    }
+
+    if (atomic_load_explicit(&found, memory_order_relaxed)) {
+        R.found = 1;
+        R.k = found_k;
+        R.g = found_g;
+        R.order = found_order;
+    }
+
+    return R;
+}
@@ -0,0 +1,691 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "instance.h"
+#include "search.h"
+
+#include <errno.h>
+#include <omp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+// Largest n accepted from a client (m_bits = n - 3 must stay < 63).
+#define SERVER_MAX_N 65
+#define SERVER_DEFAULT_CACHE 64
+
+// ---------------------------------------------------------------------------
+// Instance cache (keyed by a hash of the raw instance text)
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint64_t hash;
+    char *text; // raw instance text (exact match on hash hit)
+    size_t len;
+    Instance *I; // loaded, validated, precomputed; read-only afterwards
+    int refs;    // active requests using I
+    uint64_t last_used;
+} CacheEntry;
+
+static struct {
+    pthread_mutex_t mu;
+    CacheEntry *e;
+    int cap;
+    int used;
+    uint64_t tick;
+    uint64_t hits, misses;
+} cache = {PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, 0, 0, 0};
+
+static uint64_t fnv1a64(const char *s, size_t len) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static void instance_destroy(Instance *I) {
+    instance_free(I);
+    free(I);
+}
+
+// Parse + validate + precompute from raw text. Returns NULL on failure and
+// writes a short reason into err.
+static Instance *instance_from_text(const char *text, size_t len, char *err,
+                                   size_t err_len) {
+    int n = 0, m = 0;
+    if (sscanf(text, "%d %d", &n, &m) != 2 || n < 4 || n > SERVER_MAX_N ||
+        m <= 0 || m > n * n) {
+        snprintf(err, err_len, "bad_header");
+        return NULL;
+    }
+
+    FILE *f = fmemopen((void *)text, len, "r");
+    if (!f) {
+        snprintf(err, err_len, "out_of_memory");
+        return NULL;
+    }
+
+    Instance *I = (Instance *)malloc(sizeof(Instance));
+    if (!I) {
+        fclose(f);
+        snprintf(err, err_len, "out_of_memory");
+        return NULL;
+    }
+
+    const char *why = NULL;
+    int ok = instance_load_stream(f, I);
+    fclose(f);
+    if (!ok) {
+        snprintf(err, err_len, "parse_failed");
+    } else if (!instance_prepare(I, 0, &why)) {
+        snprintf(err, err_len, "%s", why);
+        ok = 0;
+    }
+    if (!ok) {
+        instance_destroy(I);
+        return NULL;
+    }
+    return I;
+}
+
+// Returns the cache slot index holding text, or -1. Caller holds cache.mu.
+static int cache_find(uint64_t h, const char *text, size_t len) {
+    for (int i = 0; i < cache.used; i++) {
+        CacheEntry *c = &cache.e[i];
+        if (c->hash == h && c->len == len && memcmp(c->text, text, len) == 0)
+            return i;
+    }
+    return -1;
+}
+
+// Acquire an instance for text. *slot is the cache slot (release with
+// cache_release) or -1 if the instance is not cached (caller frees it).
+static Instance *cache_acquire(const char *text, size_t len, int *slot,
+                               int *hit, char *err, size_t err_len) {
+    uint64_t h = fnv1a64(text, len);
+
+    pthread_mutex_lock(&cache.mu);
+    int i = cache_find(h, text, len);
+    if (i >= 0) {
+        Instance *I = cache.e[i].I;
+        cache.e[i].refs++;
+        cache.e[i].last_used = ++cache.tick;
+        cache.hits++;
+        pthread_mutex_unlock(&cache.mu);
+        *slot = i;
+        *hit = 1;
+        return I;
+    }
+    cache.misses++;
+    pthread_mutex_unlock(&cache.mu);
+
+    // Precompute outside the lock.
+    *hit = 0;
+    *slot = -1;
+    Instance *I = instance_from_text(text, len, err, err_len);
+    if (!I)
+        return NULL;
+
+    char *copy = (char *)malloc(len);
+    if (!copy)
+        return I;
+    memcpy(copy, text, len);
+
+    pthread_mutex_lock(&cache.mu);
+    i = cache_find(h, text, len);
+    if (i >= 0) {
+        // Someone else inserted it meanwhile.
+        Instance *J = cache.e[i].I;
+        cache.e[i].refs++;
+        cache.e[i].last_used = ++cache.tick;
+        pthread_mutex_unlock(&cache.mu);
+        free(copy);
+        instance_destroy(I);
+        *slot = i;
+        return J;
+    }
+
+    if (cache.used < cache.cap) {
+        i = cache.used++;
+    } else {
+        // Evict the least recently used idle entry.
+        for (int j = 0; j < cache.used; j++) {
+            if (cache.e[j].refs == 0 &&
+                (i < 0 || cache.e[j].last_used < cache.e[i].last_used))
+                i = j;
+        }
+        if (i >= 0) {
+            free(cache.e[i].text);
+            instance_destroy(cache.e[i].I);
+        }
+    }
+
+    if (i >= 0) {
+        cache.e[i] = (CacheEntry){h, copy, len, I, 1, ++cache.tick};
+        *slot = i;
+    } else {
+        free(copy); // cache full of busy entries: serve uncached
+    }
+    pthread_mutex_unlock(&cache.mu);
+    return I;
+}
+
+static void cache_release(int slot, Instance *I) {
+    if (slot < 0) {
+        instance_destroy(I);
+        return;
+    }
+    pthread_mutex_lock(&cache.mu);
+    cache.e[slot].refs--;
+    pthread_mutex_unlock(&cache.mu);
+}
+
+// ---------------------------------------------------------------------------
+// Jobs and worker pool
+// ---------------------------------------------------------------------------
+
+typedef struct Job {
+    char id[64];
+    const Instance *I;
+    double delta;
+    int portfolio; // mode=portfolio
+    uint64_t seed;
+
+    int done;
+    SearchResult R;
+    double search_us;
+    pthread_cond_t cv;
+
+    struct Job *next_queue;  // pending queue
+    struct Job *next_active; // registry of submitted jobs (for cancel)
+    SearchContext *ctx;      // context running this job, if any
+} Job;
+
+static struct {
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    Job *head, *tail;
+    Job *active;
+    uint64_t next_id;
+    uint64_t requests;
+} jobs = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL,
+          NULL, 0, 0};
+
+static int threads_per_worker = 1;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec * 1e-3;
+}
+
+// Each worker is a long-lived thread that owns its own OpenMP team, so the
+// team is created once and stays warm across requests. Its search context
+// is sized for SERVER_MAX_N, so requests never allocate scratch.
+static void *worker_main(void *arg) {
+    SearchContext *C = (SearchContext *)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&jobs.mu);
+        while (!jobs.head)
+            pthread_cond_wait(&jobs.cv, &jobs.mu);
+        Job *J = jobs.head;
+        jobs.head = J->next_queue;
+        if (!jobs.head)
+            jobs.tail = NULL;
+        // Cancel requests reach the context from now on (see jobs_cancel)
+        search_ctx_clear_cancel(C);
+        J->ctx = C;
+        pthread_mutex_unlock(&jobs.mu);
+
+        SearchConfig cfg = {J->portfolio ? SEARCH_MODE_PORTFOLIO
+                                         : SEARCH_MODE_FIRST,
+                            J->delta, J->seed, 0};
+        double t0 = now_us();
+        SearchResult R = search_ctx_run(C, J->I, &cfg);
+        double t1 = now_us();
+
+        pthread_mutex_lock(&jobs.mu);
+        J->ctx = NULL;
+        J->R = R;
+        J->search_us = t1 - t0;
+        J->done = 1;
+        pthread_cond_signal(&J->cv);
+        pthread_mutex_unlock(&jobs.mu);
+    }
+    return NULL;
+}
+
+// Submit J and block until a worker has finished it.
+static void job_run(Job *J) {
+    pthread_mutex_lock(&jobs.mu);
+    J->next_active = jobs.active;
+    jobs.active = J;
+    J->next_queue = NULL;
+    if (jobs.tail)
+        jobs.tail->next_queue = J;
+    else
+        jobs.head = J;
+    jobs.tail = J;
+    jobs.requests++;
+    pthread_cond_signal(&jobs.cv);
+
+    while (!J->done)
+        pthread_cond_wait(&J->cv, &jobs.mu);
+
+    for (Job **p = &jobs.active; *p; p = &(*p)->next_active) {
+        if (*p == J) {
+            *p = J->next_active;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&jobs.mu);
+}
+
+// Cancel every submitted job with this id: a running one is stopped
+// through its context, a queued one is dropped from the queue and
+// answered right away.
+static int jobs_cancel(const char *id) {
+    int count = 0;
+    pthread_mutex_lock(&jobs.mu);
+    for (Job *J = jobs.active; J; J = J->next_active) {
+        if (strcmp(J->id, id) != 0 || J->done)
+            continue;
+        if (J->ctx) {
+            search_ctx_cancel(J->ctx);
+        } else {
+            Job *prev = NULL;
+            for (Job *Q = jobs.head; Q && Q != J; Q = Q->next_queue)
+                prev = Q;
+            if (prev)
+                prev->next_queue = J->next_queue;
+            else
+                jobs.head = J->next_queue;
+            if (jobs.tail == J)
+                jobs.tail = prev;
+            J->R.cancelled = 1;
+            J->done = 1;
+            pthread_cond_signal(&J->cv);
+        }
+        count++;
+    }
+    pthread_mutex_unlock(&jobs.mu);
+    return count;
+}
+
+// ---------------------------------------------------------------------------
+// Protocol
+// ---------------------------------------------------------------------------
+//
+// One request per line, replies are one line each:
+//
+//   solve delta=<d> path=<file> [mode=first|portfolio] [seed=<s>] [id=<t>]
+//   solve delta=<d> inline [mode=first|portfolio] [seed=<s>] [id=<t>]
+//       followed by the instance text ("n m" line, then m edge lines)
+//   cancel <token>
+//   stats
+//   ping
+//   quit
+
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+    size_t cap = 4096, used = 0;
+    char *buf = (char *)malloc(cap + 1);
+    while (buf) {
+        size_t r = fread(buf + used, 1, cap - used, f);
+        used += r;
+        if (used < cap)
+            break;
+        cap *= 2;
+        char *nb = (char *)realloc(buf, cap + 1);
+        if (!nb)
+            free(buf);
+        buf = nb;
+    }
+    fclose(f);
+    if (!buf)
+        return NULL;
+    buf[used] = '\0';
+    *len = used;
+    return buf;
+}
+
+// Read the inline instance text: header line + m edge lines. A header
+// that parses but is rejected (e.g. n > SERVER_MAX_N) still has its m
+// lines consumed, so they are not taken as commands; only a header
+// without a usable m leaves the stream as is.
+static char *read_inline(FILE *in, size_t *len) {
+    char *line = NULL;
+    size_t line_cap = 0;
+    if (getline(&line, &line_cap, in) < 0) {
+        free(line);
+        return NULL;
+    }
+
+    int n = 0, m = 0;
+    if (sscanf(line, "%d %d", &n, &m) != 2 || m <= 0 ||
+        m > SERVER_MAX_N * SERVER_MAX_N) {
+        free(line);
+        return NULL;
+    }
+    int ok = n >= 4 && n <= SERVER_MAX_N && m <= n * n;
+
+    size_t cap = 256 + (size_t)m * 48, used = 0;
+    char *buf = ok ? (char *)malloc(cap) : NULL;
+    for (int e = 0; e <= m; e++) {
+        if (e > 0 && getline(&line, &line_cap, in) < 0) {
+            ok = 0;
+            break;
+        }
+        if (!buf)
+            continue; // rejected or out of memory: just drain the body
+        size_t l = strlen(line);
+        if (used + l + 1 > cap) {
+            cap = 2 * (used + l + 1);
+            char *nb = (char *)realloc(buf, cap);
+            if (!nb)
+                free(buf);
+            buf = nb;
+            if (!buf)
+                continue;
+        }
+        memcpy(buf + used, line, l);
+        used += l;
+    }
+    free(line);
+    if (!ok || !buf) {
+        free(buf);
+        return NULL;
+    }
+    buf[used] = '\0';
+    *len = used;
+    return buf;
+}
+
+static void handle_solve(char *args, FILE *in, FILE *out) {
+    Job J;
+    memset(&J, 0, sizeof(J));
+    J.delta = -1.0;
+    J.seed = 1;
+
+    const char *path = NULL;
+    const char *mode = "first";
+    int is_inline = 0;
+
+    for (char *save = NULL, *tok = strtok_r(args, " \t\r\n", &save); tok;
+         tok = strtok_r(NULL, " \t\r\n", &save)) {
+        if (strncmp(tok, "delta=", 6) == 0)
+            J.delta = strtod(tok + 6, NULL);
+        else if (strncmp(tok, "path=", 5) == 0)
+            path = tok + 5;
+        else if (strncmp(tok, "mode=", 5) == 0)
+            mode = tok + 5;
+        else if (strncmp(tok, "seed=", 5) == 0)
+            J.seed = (uint64_t)strtoull(tok + 5, NULL, 10);
+        else if (strncmp(tok, "id=", 3) == 0)
+            snprintf(J.id, sizeof(J.id), "%s", tok + 3);
+        else if (strcmp(tok, "inline") == 0)
+            is_inline = 1;
+    }
+
+    if (!J.id[0]) {
+        pthread_mutex_lock(&jobs.mu);
+        snprintf(J.id, sizeof(J.id), "%llu",
+                 (unsigned long long)++jobs.next_id);
+        pthread_mutex_unlock(&jobs.mu);
+    }
+
+    // The inline body must be consumed even if the request is rejected.
+    size_t len = 0;
+    char *text = NULL;
+    if (is_inline)
+        text = read_inline(in, &len);
+    else if (path)
+        text = read_file(path, &len);
+
+    if (!(J.delta >= 0.0)) {
+        fprintf(out, "error id=%s msg=bad_delta\n", J.id);
+        free(text);
+        return;
+    }
+    J.portfolio = (strcmp(mode, "portfolio") == 0);
+    if (!J.portfolio && strcmp(mode, "first") != 0) {
+        fprintf(out, "error id=%s msg=bad_mode\n", J.id);
+        free(text);
+        return;
+    }
+    if (!text) {
+        fprintf(out, "error id=%s msg=%s\n", J.id,
+                is_inline ? "bad_inline" : (path ? "cannot_read" : "no_input"));
+        return;
+    }
+
+    double t0 = now_us();
+    int slot = -1, hit = 0;
+    char err[64] = "";
+    Instance *I = cache_acquire(text, len, &slot, &hit, err, sizeof(err));
+    free(text);
+    double t1 = now_us();
+
+    if (!I) {
+        fprintf(out, "error id=%s msg=%s\n", J.id, err);
+        return;
+    }
+
+    J.I = I;
+    pthread_cond_init(&J.cv, NULL);
+    job_run(&J);
+    pthread_cond_destroy(&J.cv);
+
+    if (J.R.found)
+        fprintf(out,
+                "ok id=%s found=1 k=%llu g=%.12g order=%s evaluated=%llu "
+                "cached=%d prep_us=%.1f search_us=%.1f",
+                J.id, (unsigned long long)J.R.k, J.R.g,
+                search_order_name(J.R.order),
+                (unsigned long long)J.R.evaluated, hit, t1 - t0, J.search_us);
+    else
+        fprintf(out,
+                "ok id=%s found=0 cancelled=%d evaluated=%llu cached=%d "
+                "prep_us=%.1f search_us=%.1f",
+                J.id, J.R.cancelled, (unsigned long long)J.R.evaluated, hit,
+                t1 - t0, J.search_us);
+
+    // Mask bits refer to the re-ordered vertices; report the order.
+    if (I->orig) {
+        fprintf(out, " vertex_order=");
+        for (int i = 1; i <= I->n; i++)
+            fprintf(out, i > 1 ? ",%d" : "%d", I->orig[i]);
+    }
+    fprintf(out, "\n");
+
+    cache_release(slot, I);
+}
+
+static void *conn_main(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    int fd2 = dup(fd);
+    FILE *in = fdopen(fd, "r");
+    FILE *out = (fd2 >= 0) ? fdopen(fd2, "w") : NULL;
+    if (!in || !out) {
+        if (in)
+            fclose(in);
+        else
+            close(fd);
+        if (out)
+            fclose(out);
+        else if (fd2 >= 0)
+            close(fd2);
+        return NULL;
+    }
+
+    char *line = NULL;
+    size_t cap = 0;
+    while (getline(&line, &cap, in) >= 0) {
+        char *cmd = line + strspn(line, " \t");
+        size_t cl = strcspn(cmd, " \t\r\n");
+        char *args = cmd + cl;
+
+        if (cl == 5 && strncmp(cmd, "solve", 5) == 0) {
+            handle_solve(args, in, out);
+        } else if (cl == 6 && strncmp(cmd, "cancel", 6) == 0) {
+            char *id = args + strspn(args, " \t");
+            id[strcspn(id, " \t\r\n")] = '\0';
+            fprintf(out, "ok cancelled=%d\n", jobs_cancel(id));
+        } else if (cl == 5 && strncmp(cmd, "stats", 5) == 0) {
+            pthread_mutex_lock(&cache.mu);
+            int used = cache.used;
+            uint64_t hits = cache.hits, misses = cache.misses;
+            pthread_mutex_unlock(&cache.mu);
+            pthread_mutex_lock(&jobs.mu);
+            uint64_t requests = jobs.requests;
+            pthread_mutex_unlock(&jobs.mu);
+            fprintf(out,
+                    "ok requests=%llu cached=%d cache_hits=%llu "
+                    "cache_misses=%llu\n",
+                    (unsigned long long)requests, used,
+                    (unsigned long long)hits, (unsigned long long)misses);
+        } else if (cl == 4 && strncmp(cmd, "ping", 4) == 0) {
+            fprintf(out, "pong\n");
+        } else if (cl == 4 && strncmp(cmd, "quit", 4) == 0) {
+            break;
+        } else if (cl > 0) {
+            fprintf(out, "error msg=unknown_command\n");
+        }
+        fflush(out);
+    }
+
+    free(line);
+    fclose(out);
+    fclose(in);
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "usage: %s <socket_path> [workers] [cache_capacity]\n",
+            prog);
+    fprintf(stderr, "example: %s /tmp/dmdgp.sock 1 64\n", prog);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *sock_path = argv[1];
+    int workers = (argc > 2) ? atoi(argv[2]) : 1;
+    cache.cap = (argc > 3) ? atoi(argv[3]) : SERVER_DEFAULT_CACHE;
+    if (workers < 1 || cache.cap < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    // Split the OpenMP threads between the workers.
+    threads_per_worker = omp_get_max_threads() / workers;
+    if (threads_per_worker < 1)
+        threads_per_worker = 1;
+
+    cache.e = (CacheEntry *)calloc((size_t)cache.cap + 1, sizeof(CacheEntry));
+    if (!cache.e) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        return 1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(sock_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "ERROR: socket path too long: %s\n", sock_path);
+        return 1;
+    }
+    strcpy(addr.sun_path, sock_path);
+
+    int lfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) {
+        fprintf(stderr, "ERROR: socket failed (%s)\n", strerror(errno));
+        return 1;
+    }
+    unlink(sock_path);
+    if (bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(lfd, 64) != 0) {
+        fprintf(stderr, "ERROR: cannot listen on %s (%s)\n", sock_path,
+                strerror(errno));
+        close(lfd);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal; // no SA_RESTART: accept() returns EINTR
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    SearchContext *ctxs =
+        (SearchContext *)calloc((size_t)workers, sizeof(SearchContext));
+    for (int w = 0; w < workers; w++) {
+        if (!ctxs || !search_ctx_init(&ctxs[w], threads_per_worker,
+                                      SERVER_MAX_N)) {
+            fprintf(stderr, "ERROR: out of memory\n");
+            close(lfd);
+            unlink(sock_path);
+            return 1;
+        }
+    }
+
+    for (int w = 0; w < workers; w++) {
+        pthread_t th;
+        if (pthread_create(&th, NULL, worker_main, &ctxs[w]) != 0) {
+            fprintf(stderr, "ERROR: cannot start worker thread\n");
+            close(lfd);
+            unlink(sock_path);
+            return 1;
+        }
+        pthread_detach(th);
+    }
+
+    fprintf(stderr, "listening on %s (workers=%d, threads/worker=%d, "
+                    "cache=%d)\n",
+            sock_path, workers, threads_per_worker, cache.cap);
+
+    while (!stop) {
+        int cfd = accept(lfd, NULL, NULL);
+        if (cfd < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "ERROR: accept failed (%s)\n", strerror(errno));
+            break;
+        }
+        pthread_t th;
+        if (pthread_create(&th, NULL, conn_main, (void *)(intptr_t)cfd) != 0) {
+            close(cfd);
+            continue;
+        }
+        pthread_detach(th);
+    }
+
+    close(lfd);
+    unlink(sock_path);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#!/bin/sh
+# Regression check for vertex re-ordering: relabel each instance with a
+# random permutation, solve it, and verify g(x) <= delta on the original
+# edges using the points printed in the shuffled instance's ids.
+#
+# usage: tests/reorder_check.sh [delta] [seeds] [instance...]
+
+BUILD=${BUILD:-build}
+DELTA=${1:-1e-6}
+SEEDS=${2:-6}
+[ $# -gt 2 ] && shift 2 || set -- data/*.in
+
+TMP=$(mktemp -d) || exit 1
+trap 'rm -rf "$TMP"' EXIT
+
+fail=0
+for inst in "$@"; do
+    s=1
+    while [ "$s" -le "$SEEDS" ]; do
+        shuf="$TMP/$(basename "$inst" .in)_$s.in"
+
+        # Relabel vertex v as p[v] (Fisher-Yates with awk's seeded rand)
+        awk -v seed="$s" '
+            NR == 1 {
+                n = $1; print
+                srand(seed)
+                for (v = 1; v <= n; v++) p[v] = v
+                for (v = n; v > 1; v--) {
+                    j = int(rand() * v) + 1
+                    t = p[v]; p[v] = p[j]; p[j] = t
+                }
+                next
+            }
+            NF == 3 { printf "%d %d %s\n", p[$1], p[$2], $3 }
+        ' "$inst" >"$shuf"
+
+        k=$("$BUILD/search" "$shuf" "$DELTA" 2>"$TMP/err" |
+            sed -n 's/^FOUND: k=\([0-9]*\).*/\1/p')
+        if [ -z "$k" ]; then
+            echo "FAIL $inst seed=$s: $(tail -n 1 "$TMP/err")"
+            fail=1
+            s=$((s + 1))
+            continue
+        fi
+
+        "$BUILD/points" "$shuf" "$k" >"$TMP/pts" 2>/dev/null
+        if ! awk -v delta="$DELTA" '
+                FNR == 1 { file++ }
+                file == 1 && NF == 4 { x[$1] = $2; y[$1] = $3; z[$1] = $4 }
+                file == 2 && FNR > 1 && NF == 3 {
+                    if (!($1 in x) || !($2 in x)) exit 1
+                    dx = x[$1] - x[$2]; dy = y[$1] - y[$2]; dz = z[$1] - z[$2]
+                    e = dx * dx + dy * dy + dz * dz - $3 * $3
+                    g += e * e
+                }
+                END { exit !(g <= delta) }
+            ' "$TMP/pts" "$shuf"; then
+            echo "FAIL $inst seed=$s: k=$k does not satisfy delta=$DELTA"
+            fail=1
+        else
+            echo "ok   $inst seed=$s k=$k"
+        fi
+        s=$((s + 1))
+    done
+done
+
+exit $fail